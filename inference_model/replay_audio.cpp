@@ -0,0 +1,939 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <dlfcn.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <model.h>
+#include <interpreter.h>
+#include <kernels/register.h>
+
+// Replays WAV files as N simultaneous real-time audio streams through the
+// feature -> inference -> decision path and reports how the box keeps up.
+//
+// Every stream plays the input files back to back (looped), each stream
+// starting at a different file. Every hop a window of the most recent audio
+// is released as a job: the worker trims it, fixes it to 0.5 s, extracts the
+// MFCC exactly like preprocess_audio() in compile_model/compile/main.py,
+// runs the model and takes the argmax as the decision. A job misses its
+// deadline if the decision is not ready deadline_ms after the window ended.
+
+typedef TfLiteDelegate* (*Create_delegate)(char**,
+                                           char**,
+                                           size_t,
+                                           void (*report_error)(const char *));
+
+typedef std::chrono::steady_clock Clock;
+
+// Feature parameters, matching librosa.load(sr=48000), effects.trim(top_db=10),
+// util.fix_length(size=24000) and feature.mfcc(n_mfcc=20) defaults
+static const int kSampleRate = 48000;
+static const int kNumSamples = 24000;
+static const int kNFft = 2048;
+static const int kHop = 512;
+static const int kNBins = kNFft / 2 + 1;
+static const int kNMels = 128;
+static const int kNMfcc = 20;
+static const int kNFrames = 1 + kNumSamples / kHop;
+static const double kTrimTopDb = 10.0;
+static const double kTopDb = 80.0;
+static const double kAmin = 1e-10;
+
+// TIDL error reporter callback
+void tidl_error_reporter(const char* msg) {
+    std::cerr << "TIDL: " << msg << std::endl;
+}
+
+static uint32_t read_u32(const unsigned char* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t read_u16(const unsigned char* p) {
+    return p[0] | (p[1] << 8);
+}
+
+// Loads a PCM16/PCM32/float32 WAV file, averaging channels down to mono
+bool load_wav(const std::string& path, std::vector<float>& samples, int& sample_rate) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open WAV file: " << path << std::endl;
+        return false;
+    }
+    std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)),
+                                     std::istreambuf_iterator<char>());
+    if (bytes.size() < 12 || memcmp(bytes.data(), "RIFF", 4) != 0 ||
+        memcmp(bytes.data() + 8, "WAVE", 4) != 0) {
+        std::cerr << "Not a RIFF/WAVE file: " << path << std::endl;
+        return false;
+    }
+
+    int format = 0, channels = 0, bits = 0;
+    const unsigned char* data = nullptr;
+    size_t data_size = 0;
+    size_t pos = 12;
+    while (pos + 8 <= bytes.size()) {
+        const unsigned char* chunk = bytes.data() + pos;
+        size_t size = read_u32(chunk + 4);
+        size_t body = pos + 8;
+        if (body + size > bytes.size()) {
+            size = bytes.size() - body;
+        }
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            format = read_u16(chunk + 8);
+            channels = read_u16(chunk + 10);
+            sample_rate = read_u32(chunk + 12);
+            bits = read_u16(chunk + 22);
+            // WAVE_FORMAT_EXTENSIBLE keeps the real format in the sub-format GUID
+            if (format == 0xFFFE && size >= 26) {
+                format = read_u16(chunk + 32);
+            }
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            data = chunk + 8;
+            data_size = size;
+        }
+        pos = body + size + (size & 1);
+    }
+
+    if (data == nullptr || channels <= 0 || sample_rate <= 0) {
+        std::cerr << "Missing fmt or data chunk in: " << path << std::endl;
+        return false;
+    }
+    if (!((format == 1 && (bits == 16 || bits == 32)) || (format == 3 && bits == 32))) {
+        std::cerr << "Unsupported WAV encoding (format " << format << ", "
+                  << bits << " bits) in: " << path << std::endl;
+        return false;
+    }
+
+    const size_t frame_bytes = (bits / 8) * channels;
+    const size_t num_frames = data_size / frame_bytes;
+    samples.assign(num_frames, 0.0f);
+    for (size_t i = 0; i < num_frames; i++) {
+        float sum = 0.0f;
+        for (int c = 0; c < channels; c++) {
+            const unsigned char* p = data + i * frame_bytes + c * (bits / 8);
+            if (format == 3) {
+                uint32_t raw = read_u32(p);
+                float value;
+                std::memcpy(&value, &raw, sizeof(value));
+                sum += value;
+            } else if (bits == 16) {
+                sum += (int16_t)read_u16(p) / 32768.0f;
+            } else {
+                sum += (int32_t)read_u32(p) / 2147483648.0f;
+            }
+        }
+        samples[i] = sum / channels;
+    }
+    return true;
+}
+
+// Band-limited (Hann windowed sinc) resampling, the offline counterpart of
+// librosa.load(sr=48000). Only used while loading, never per job.
+std::vector<float> resample(const std::vector<float>& in, int src_rate, int dst_rate) {
+    if (src_rate == dst_rate || in.empty()) {
+        return in;
+    }
+    const double ratio = (double)dst_rate / src_rate;
+    const double cutoff = std::min(1.0, ratio);
+    const double support = 16.0 / cutoff;
+    const long last = (long)in.size() - 1;
+    std::vector<float> out((size_t)std::ceil(in.size() * ratio));
+    for (size_t n = 0; n < out.size(); n++) {
+        const double t = n / ratio;
+        const long lo = std::max(0L, (long)std::ceil(t - support));
+        const long hi = std::min(last, (long)std::floor(t + support));
+        double acc = 0.0;
+        for (long k = lo; k <= hi; k++) {
+            const double x = t - k;
+            const double arg = M_PI * cutoff * x;
+            const double sinc = (x == 0.0) ? 1.0 : std::sin(arg) / arg;
+            const double window = 0.5 + 0.5 * std::cos(M_PI * x / support);
+            acc += in[k] * cutoff * sinc * window;
+        }
+        out[n] = (float)acc;
+    }
+    return out;
+}
+
+// Collects the WAV files named on the command line; directories expand to
+// their *.wav entries in sorted order
+bool collect_wavs(const std::string& path, std::vector<std::string>& files) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        std::cerr << "No such file or directory: " << path << std::endl;
+        return false;
+    }
+    if (!(info.st_mode & S_IFDIR)) {
+        files.push_back(path);
+        return true;
+    }
+    DIR* dir = opendir(path.c_str());
+    if (dir == NULL) {
+        std::cerr << "Failed to open directory: " << path << std::endl;
+        return false;
+    }
+    std::vector<std::string> found;
+    while (struct dirent* entry = readdir(dir)) {
+        std::string name(entry->d_name);
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".wav") == 0) {
+            found.push_back(path + "/" + name);
+        }
+    }
+    closedir(dir);
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+    return true;
+}
+
+static double hz_to_mel(double hz) {
+    // Slaney scale: linear below 1 kHz, logarithmic above
+    const double f_sp = 200.0 / 3;
+    const double min_log_hz = 1000.0;
+    const double min_log_mel = min_log_hz / f_sp;
+    const double logstep = std::log(6.4) / 27.0;
+    if (hz >= min_log_hz) {
+        return min_log_mel + std::log(hz / min_log_hz) / logstep;
+    }
+    return hz / f_sp;
+}
+
+static double mel_to_hz(double mel) {
+    const double f_sp = 200.0 / 3;
+    const double min_log_hz = 1000.0;
+    const double min_log_mel = min_log_hz / f_sp;
+    const double logstep = std::log(6.4) / 27.0;
+    if (mel >= min_log_mel) {
+        return min_log_hz * std::exp(logstep * (mel - min_log_mel));
+    }
+    return f_sp * mel;
+}
+
+// Trim -> fix_length -> MFCC for one audio window. All tables and scratch
+// buffers are built once so compute() does not allocate.
+class MfccExtractor {
+public:
+    MfccExtractor(size_t max_window)
+        : window_(kNFft), mel_basis_(kNMels * kNBins), mel_first_(kNMels), mel_last_(kNMels),
+          dct_(kNMfcc * kNMels),
+          twiddle_re_(kNFft / 2), twiddle_im_(kNFft / 2), bitrev_(kNFft),
+          energy_(max_window + 1), padded_(kNumSamples + kNFft),
+          re_(kNFft), im_(kNFft), power_(kNBins), log_mel_(kNFrames * kNMels) {
+        // Periodic Hann window (scipy.signal.get_window("hann", fftbins=True))
+        for (int n = 0; n < kNFft; n++) {
+            window_[n] = 0.5f - 0.5f * std::cos(2.0 * M_PI * n / kNFft);
+        }
+
+        // Slaney-normalised mel filterbank over 0..sr/2
+        std::vector<double> mel_f(kNMels + 2);
+        const double mel_max = hz_to_mel(kSampleRate / 2.0);
+        for (int i = 0; i < kNMels + 2; i++) {
+            mel_f[i] = mel_to_hz(mel_max * i / (kNMels + 1));
+        }
+        for (int m = 0; m < kNMels; m++) {
+            const double enorm = 2.0 / (mel_f[m + 2] - mel_f[m]);
+            for (int k = 0; k < kNBins; k++) {
+                const double freq = (double)k * kSampleRate / kNFft;
+                const double lower = (freq - mel_f[m]) / (mel_f[m + 1] - mel_f[m]);
+                const double upper = (mel_f[m + 2] - freq) / (mel_f[m + 2] - mel_f[m + 1]);
+                mel_basis_[m * kNBins + k] =
+                    (float)(std::max(0.0, std::min(lower, upper)) * enorm);
+            }
+            // Each triangle only covers a few bins; remember where it is non-zero
+            int first = 0, last = kNBins;
+            while (first < kNBins && mel_basis_[m * kNBins + first] == 0.0f) first++;
+            while (last > first && mel_basis_[m * kNBins + last - 1] == 0.0f) last--;
+            mel_first_[m] = first;
+            mel_last_[m] = last;
+        }
+
+        // Orthonormal DCT-II, first kNMfcc rows
+        for (int k = 0; k < kNMfcc; k++) {
+            const double scale = std::sqrt((k == 0 ? 1.0 : 2.0) / kNMels);
+            for (int n = 0; n < kNMels; n++) {
+                dct_[k * kNMels + n] =
+                    (float)(scale * std::cos(M_PI * k * (2 * n + 1) / (2.0 * kNMels)));
+            }
+        }
+
+        for (int i = 0; i < kNFft / 2; i++) {
+            twiddle_re_[i] = (float)std::cos(-2.0 * M_PI * i / kNFft);
+            twiddle_im_[i] = (float)std::sin(-2.0 * M_PI * i / kNFft);
+        }
+        int bits = 0;
+        while ((1 << bits) < kNFft) bits++;
+        for (int i = 0; i < kNFft; i++) {
+            int r = 0;
+            for (int b = 0; b < bits; b++) {
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            bitrev_[i] = r;
+        }
+    }
+
+    // Writes kNFrames x kNMfcc values in the time-major layout of mfcc_data.h
+    void compute(const float* audio, size_t length, float* out) {
+        size_t start = 0, end = 0;
+        trim(audio, length, start, end);
+
+        // fix_length to kNumSamples, then centre padding (pad_mode="constant")
+        const size_t kept = std::min(end - start, (size_t)kNumSamples);
+        std::fill(padded_.begin(), padded_.end(), 0.0f);
+        std::copy(audio + start, audio + start + kept, padded_.begin() + kNFft / 2);
+
+        float max_db = -1e30f;
+        for (int t = 0; t < kNFrames; t++) {
+            const float* frame = padded_.data() + t * kHop;
+            for (int n = 0; n < kNFft; n++) {
+                re_[bitrev_[n]] = frame[n] * window_[n];
+                im_[bitrev_[n]] = 0.0f;
+            }
+            fft();
+            for (int k = 0; k < kNBins; k++) {
+                power_[k] = re_[k] * re_[k] + im_[k] * im_[k];
+            }
+            for (int m = 0; m < kNMels; m++) {
+                const float* weights = mel_basis_.data() + m * kNBins;
+                float acc = 0.0f;
+                for (int k = mel_first_[m]; k < mel_last_[m]; k++) {
+                    acc += weights[k] * power_[k];
+                }
+                float db = 10.0f * std::log10(std::max((float)kAmin, acc));
+                log_mel_[t * kNMels + m] = db;
+                max_db = std::max(max_db, db);
+            }
+        }
+
+        // power_to_db(top_db=80) clamps against the maximum of the whole window
+        const float floor_db = max_db - (float)kTopDb;
+        for (int t = 0; t < kNFrames; t++) {
+            float* column = log_mel_.data() + t * kNMels;
+            for (int m = 0; m < kNMels; m++) {
+                column[m] = std::max(column[m], floor_db);
+            }
+            for (int k = 0; k < kNMfcc; k++) {
+                const float* basis = dct_.data() + k * kNMels;
+                float acc = 0.0f;
+                for (int m = 0; m < kNMels; m++) {
+                    acc += basis[m] * column[m];
+                }
+                out[t * kNMfcc + k] = acc;
+            }
+        }
+    }
+
+private:
+    // librosa.effects.trim: keep frames whose RMS energy is within kTrimTopDb of
+    // the loudest frame (frame_length=2048, hop_length=512, centred frames)
+    void trim(const float* audio, size_t length, size_t& start, size_t& end) {
+        energy_[0] = 0.0;
+        for (size_t i = 0; i < length; i++) {
+            energy_[i + 1] = energy_[i] + (double)audio[i] * audio[i];
+        }
+        const size_t num_frames = 1 + length / kHop;
+        double max_mse = 0.0;
+        for (size_t t = 0; t < num_frames; t++) {
+            max_mse = std::max(max_mse, frame_mse(t, length));
+        }
+        const double ref_db = 10.0 * std::log10(std::max(kAmin, max_mse));
+        long first = -1, last = -1;
+        for (size_t t = 0; t < num_frames; t++) {
+            double db = 10.0 * std::log10(std::max(kAmin, frame_mse(t, length))) - ref_db;
+            if (db > -kTrimTopDb) {
+                if (first < 0) first = t;
+                last = t;
+            }
+        }
+        if (first < 0) {
+            start = end = 0;
+            return;
+        }
+        start = std::min((size_t)first * kHop, length);
+        end = std::min((size_t)(last + 1) * kHop, length);
+    }
+
+    double frame_mse(size_t t, size_t length) const {
+        const long centre = (long)(t * kHop);
+        const size_t lo = (size_t)std::max(0L, centre - kNFft / 2);
+        const size_t hi = (size_t)std::min((long)length, centre + kNFft / 2);
+        return (hi > lo ? energy_[hi] - energy_[lo] : 0.0) / kNFft;
+    }
+
+    // In-place radix-2 FFT on re_/im_, input already in bit-reversed order
+    void fft() {
+        for (int size = 2; size <= kNFft; size <<= 1) {
+            const int half = size / 2;
+            const int step = kNFft / size;
+            for (int i = 0; i < kNFft; i += size) {
+                for (int j = 0; j < half; j++) {
+                    const float wr = twiddle_re_[j * step];
+                    const float wi = twiddle_im_[j * step];
+                    const int a = i + j, b = a + half;
+                    const float tr = re_[b] * wr - im_[b] * wi;
+                    const float ti = re_[b] * wi + im_[b] * wr;
+                    re_[b] = re_[a] - tr;
+                    im_[b] = im_[a] - ti;
+                    re_[a] += tr;
+                    im_[a] += ti;
+                }
+            }
+        }
+    }
+
+    std::vector<float> window_;
+    std::vector<float> mel_basis_;
+    std::vector<int> mel_first_;
+    std::vector<int> mel_last_;
+    std::vector<float> dct_;
+    std::vector<float> twiddle_re_;
+    std::vector<float> twiddle_im_;
+    std::vector<int> bitrev_;
+    std::vector<double> energy_;
+    std::vector<float> padded_;
+    std::vector<float> re_;
+    std::vector<float> im_;
+    std::vector<float> power_;
+    std::vector<float> log_mel_;
+};
+
+struct Job {
+    size_t offset;             // first sample of the window in the looped audio
+    Clock::time_point release; // when the last sample of the window "arrived"
+    Clock::time_point deadline;
+};
+
+// Bounded FIFO between the replay clock and the workers. A full queue drops
+// the job, which is what a real capture path would have to do.
+class JobQueue {
+public:
+    explicit JobQueue(size_t capacity) : capacity_(capacity) {}
+
+    bool push(const Job& job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (jobs_.size() >= capacity_) {
+                return false;
+            }
+            jobs_.push_back(job);
+            depth_sum_ += jobs_.size();
+            depth_samples_++;
+            depth_max_ = std::max(depth_max_, jobs_.size());
+        }
+        ready_.notify_one();
+        return true;
+    }
+
+    // Blocks until a job is available; returns false once closed and drained
+    bool pop(Job& job) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return closed_ || !jobs_.empty(); });
+        if (jobs_.empty()) {
+            return false;
+        }
+        job = jobs_.front();
+        jobs_.pop_front();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        ready_.notify_all();
+    }
+
+    double depth_mean() const {
+        return depth_samples_ ? (double)depth_sum_ / depth_samples_ : 0.0;
+    }
+
+    size_t depth_max() const { return depth_max_; }
+
+private:
+    size_t capacity_;
+    std::deque<Job> jobs_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    bool closed_ = false;
+    size_t depth_sum_ = 0;
+    size_t depth_samples_ = 0;
+    size_t depth_max_ = 0;
+};
+
+// One interpreter per worker thread; tflite::Interpreter is not thread safe
+struct Worker {
+    std::unique_ptr<tflite::Interpreter> interpreter;
+    std::unique_ptr<MfccExtractor> extractor;
+    std::vector<float> window;
+    std::vector<double> latencies_ms;
+    double busy_s = 0.0;
+    long jobs = 0;
+    long misses = 0;
+    long detections = 0;
+    long failures = 0;
+};
+
+struct ReplayConfig {
+    std::vector<int> streams = {1, 2, 4, 8, 16};
+    double rate = 1.0;
+    double duration_s = 20.0;
+    double window_ms = 1000.0;
+    double hop_ms = 250.0;
+    double deadline_ms = -1.0;  // defaults to hop_ms
+    int workers = 0;            // defaults to hardware_concurrency()
+    int threads = 1;
+    int queue_depth = 256;
+    float threshold = 0.5f;
+    double max_miss_pct = 1.0;
+};
+
+struct StepResult {
+    long jobs = 0;
+    long dropped = 0;
+    long misses = 0;
+    long detections = 0;
+    long failures = 0;
+    double p50_ms = 0, p95_ms = 0, p99_ms = 0, max_ms = 0;
+    double rtf = 0;
+    double load_pct = 0;
+    double queue_mean = 0;
+    size_t queue_max = 0;
+    double cpu_pct = 0;
+};
+
+static double cpu_seconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 +
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+}
+
+static double seconds_between(Clock::time_point a, Clock::time_point b) {
+    return std::chrono::duration<double>(b - a).count();
+}
+
+void run_worker(Worker& worker, JobQueue& queue, const std::vector<float>& audio,
+                float threshold) {
+    const size_t total = audio.size();
+    const size_t length = worker.window.size();
+    float* input = worker.interpreter->typed_input_tensor<float>(0);
+    const TfLiteTensor* output_tensor =
+        worker.interpreter->output_tensor(0);
+    const int num_classes = output_tensor->bytes / sizeof(float);
+
+    Job job;
+    while (queue.pop(job)) {
+        auto begin = Clock::now();
+
+        // Copy the window out of the looped stream audio
+        size_t first = std::min(length, total - job.offset);
+        std::copy(audio.begin() + job.offset, audio.begin() + job.offset + first,
+                  worker.window.begin());
+        for (size_t copied = first; copied < length; copied += total) {
+            size_t count = std::min(total, length - copied);
+            std::copy(audio.begin(), audio.begin() + count, worker.window.begin() + copied);
+        }
+
+        worker.extractor->compute(worker.window.data(), length, input);
+
+        bool ok = worker.interpreter->Invoke() == kTfLiteOk;
+        if (ok) {
+            const float* scores = worker.interpreter->typed_output_tensor<float>(0);
+            int best = 0;
+            for (int j = 1; j < num_classes; j++) {
+                if (scores[j] > scores[best]) best = j;
+            }
+            if (scores[best] >= threshold) {
+                worker.detections++;
+            }
+        } else {
+            worker.failures++;
+        }
+
+        auto done = Clock::now();
+        worker.busy_s += seconds_between(begin, done);
+        worker.latencies_ms.push_back(seconds_between(job.release, done) * 1000.0);
+        worker.jobs++;
+        if (done > job.deadline) {
+            worker.misses++;
+        }
+    }
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t index = (size_t)std::ceil(p / 100.0 * sorted.size());
+    return sorted[std::min(sorted.size() - 1, index > 0 ? index - 1 : 0)];
+}
+
+StepResult run_step(int num_streams, const ReplayConfig& config,
+                    std::vector<Worker>& workers, const std::vector<float>& audio,
+                    const std::vector<size_t>& file_starts) {
+    const size_t total = audio.size();
+    const double window_s = config.window_ms / 1000.0;
+    const double hop_s = config.hop_ms / 1000.0;
+    const size_t hop_samples = (size_t)(hop_s * kSampleRate);
+    const long jobs_per_stream = (long)((config.duration_s - window_s) / hop_s) + 1;
+    const auto deadline = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(config.deadline_ms / 1000.0 / config.rate));
+
+    JobQueue queue(config.queue_depth);
+    for (Worker& worker : workers) {
+        worker.latencies_ms.clear();
+        // Any worker may end up with every job; never grow inside the timed run
+        worker.latencies_ms.reserve(jobs_per_stream * num_streams);
+        worker.busy_s = 0.0;
+        worker.jobs = worker.misses = worker.detections = worker.failures = 0;
+    }
+
+    std::vector<std::thread> threads;
+    for (Worker& worker : workers) {
+        threads.emplace_back(run_worker, std::ref(worker), std::ref(queue),
+                             std::cref(audio), config.threshold);
+    }
+
+    // Streams are staggered evenly across one hop so their windows do not all
+    // complete on the same tick; release order is then hop-major, stream-minor
+    StepResult result;
+    const double cpu_start = cpu_seconds();
+    const auto start = Clock::now();
+    for (long k = 0; k < jobs_per_stream; k++) {
+        for (int s = 0; s < num_streams; s++) {
+            const double audio_time = window_s + k * hop_s + s * hop_s / num_streams;
+            Job job;
+            job.offset = (file_starts[s % file_starts.size()] + k * hop_samples) % total;
+            job.release = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(audio_time / config.rate));
+            job.deadline = job.release + deadline;
+            std::this_thread::sleep_until(job.release);
+            if (!queue.push(job)) {
+                result.dropped++;
+            }
+        }
+    }
+    queue.close();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    const double wall_s = seconds_between(start, Clock::now());
+    const double cpu_s = cpu_seconds() - cpu_start;
+
+    std::vector<double> latencies;
+    double busy_s = 0.0;
+    for (const Worker& worker : workers) {
+        latencies.insert(latencies.end(), worker.latencies_ms.begin(), worker.latencies_ms.end());
+        busy_s += worker.busy_s;
+        result.jobs += worker.jobs;
+        result.misses += worker.misses;
+        result.detections += worker.detections;
+        result.failures += worker.failures;
+    }
+    // Report latency on the audio clock, like the deadline, so the columns
+    // compare directly against --deadline-ms at any --rate
+    for (double& latency : latencies) {
+        latency *= config.rate;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    result.p50_ms = percentile(latencies, 50);
+    result.p95_ms = percentile(latencies, 95);
+    result.p99_ms = percentile(latencies, 99);
+    result.max_ms = latencies.empty() ? 0.0 : latencies.back();
+    // Dropped windows never produce a decision, so they count as misses too
+    result.misses += result.dropped;
+    result.rtf = result.jobs ? busy_s / (result.jobs * hop_s) : 0.0;
+    result.load_pct = 100.0 * busy_s / (wall_s * workers.size());
+    result.queue_mean = queue.depth_mean();
+    result.queue_max = queue.depth_max();
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    result.cpu_pct = 100.0 * cpu_s / (wall_s * cores);
+    return result;
+}
+
+static bool parse_streams(const char* text, std::vector<int>& streams) {
+    streams.clear();
+    std::string list(text);
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) comma = list.size();
+        int n = std::atoi(list.substr(pos, comma - pos).c_str());
+        if (n <= 0) return false;
+        streams.push_back(n);
+        pos = comma + 1;
+    }
+    std::sort(streams.begin(), streams.end());
+    streams.erase(std::unique(streams.begin(), streams.end()), streams.end());
+    return !streams.empty();
+}
+
+static void print_usage(const char* argv0) {
+    std::cout << "Usage: " << argv0 << " [options] [wav files or directories...]\n"
+              << "  --model PATH        TFLite model (default model/model.tflite)\n"
+              << "  --tidl              Apply the TIDL delegate to every interpreter\n"
+              << "  --artifacts PATH    TIDL artifacts (default ./classification/artifacts)\n"
+              << "  --streams LIST      Stream counts to sweep (default 1,2,4,8,16)\n"
+              << "  --rate R            Replay speed, 1 = real time (default 1)\n"
+              << "  --duration S        Seconds of audio per stream per step (default 20)\n"
+              << "  --window-ms MS      Audio per decision before trimming (default 1000)\n"
+              << "  --hop-ms MS         New audio between decisions (default 250)\n"
+              << "  --deadline-ms MS    Decision deadline after window end (default hop)\n"
+              << "  --workers W         Inference threads (default: number of cores)\n"
+              << "  --threads T         TFLite threads per interpreter (default 1)\n"
+              << "  --queue-depth Q     Pending windows before dropping (default 256)\n"
+              << "  --threshold P       Score needed to count a detection (default 0.5)\n"
+              << "  --max-miss-pct P    Miss rate still counted as sustained (default 1)\n"
+              << "WAV files default to sample_audio/." << std::endl;
+}
+
+int main(int argc, char** argv) {
+    ReplayConfig config;
+    const char* model_path = "model/model.tflite";
+    const char* artifacts_path = "./classification/artifacts";
+    bool enableTidl = false;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        bool has_value = i + 1 < argc;
+        if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--tidl") {
+            enableTidl = true;
+        } else if (arg.compare(0, 2, "--") == 0 && !has_value) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            print_usage(argv[0]);
+            return -1;
+        } else if (arg == "--model") {
+            model_path = argv[++i];
+        } else if (arg == "--artifacts") {
+            artifacts_path = argv[++i];
+        } else if (arg == "--streams") {
+            if (!parse_streams(argv[++i], config.streams)) {
+                std::cerr << "Invalid stream list: " << argv[i] << std::endl;
+                return -1;
+            }
+        } else if (arg == "--rate") {
+            config.rate = std::atof(argv[++i]);
+        } else if (arg == "--duration") {
+            config.duration_s = std::atof(argv[++i]);
+        } else if (arg == "--window-ms") {
+            config.window_ms = std::atof(argv[++i]);
+        } else if (arg == "--hop-ms") {
+            config.hop_ms = std::atof(argv[++i]);
+        } else if (arg == "--deadline-ms") {
+            config.deadline_ms = std::atof(argv[++i]);
+        } else if (arg == "--workers") {
+            config.workers = std::atoi(argv[++i]);
+        } else if (arg == "--threads") {
+            config.threads = std::atoi(argv[++i]);
+        } else if (arg == "--queue-depth") {
+            config.queue_depth = std::atoi(argv[++i]);
+        } else if (arg == "--threshold") {
+            config.threshold = std::atof(argv[++i]);
+        } else if (arg == "--max-miss-pct") {
+            config.max_miss_pct = std::atof(argv[++i]);
+        } else if (arg.compare(0, 2, "--") == 0) {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            print_usage(argv[0]);
+            return -1;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) {
+        inputs.push_back("sample_audio");
+    }
+    if (config.deadline_ms <= 0) {
+        config.deadline_ms = config.hop_ms;
+    }
+    if (config.workers <= 0) {
+        config.workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (config.rate <= 0 || config.hop_ms <= 0 || config.window_ms <= 0 ||
+        config.queue_depth <= 0 || config.duration_s < config.window_ms / 1000.0) {
+        std::cerr << "Rate, hop, window and queue depth must be positive and the "
+                  << "duration at least one window" << std::endl;
+        return -1;
+    }
+
+    // Load every WAV once at the model rate and lay them out back to back
+    std::vector<std::string> files;
+    for (const std::string& input : inputs) {
+        if (!collect_wavs(input, files)) {
+            return -1;
+        }
+    }
+    std::vector<float> audio;
+    std::vector<size_t> file_starts;
+    for (const std::string& path : files) {
+        std::vector<float> samples;
+        int sample_rate = 0;
+        if (!load_wav(path, samples, sample_rate)) {
+            return -1;
+        }
+        samples = resample(samples, sample_rate, kSampleRate);
+        file_starts.push_back(audio.size());
+        audio.insert(audio.end(), samples.begin(), samples.end());
+    }
+    if (audio.empty()) {
+        std::cerr << "No audio found in the given WAV files" << std::endl;
+        return -1;
+    }
+    std::cout << "Loaded " << files.size() << " WAV files, "
+              << audio.size() / (double)kSampleRate << " s of audio at "
+              << kSampleRate << " Hz" << std::endl;
+
+    std::unique_ptr<tflite::FlatBufferModel> model = tflite::FlatBufferModel::BuildFromFile(model_path);
+    if (!model) {
+        std::cerr << "Failed to load model from: " << model_path << std::endl;
+        return -1;
+    }
+
+    Create_delegate createPlugin = NULL;
+    if (enableTidl) {
+        struct stat info;
+        if (stat(artifacts_path, &info) != 0 || !(info.st_mode & S_IFDIR)) {
+            std::cerr << "ERROR: Artifacts folder does not exist: " << artifacts_path << std::endl;
+            return -1;
+        }
+        void* lib = dlopen("/usr/lib/libtidl_tfl_delegate.so", RTLD_NOW | RTLD_LOCAL);
+        if (lib == NULL) {
+            std::cerr << "Could not load TIDL delegate library: " << dlerror() << std::endl;
+            return -1;
+        }
+        createPlugin = (Create_delegate)dlsym(lib, "tflite_plugin_create_delegate");
+        if (createPlugin == NULL) {
+            std::cerr << "Could not find delegate creation function: " << dlerror() << std::endl;
+            return -1;
+        }
+    }
+
+    const size_t window_samples = (size_t)(config.window_ms / 1000.0 * kSampleRate);
+    tflite::ops::builtin::BuiltinOpResolver resolver;
+    std::vector<Worker> workers(config.workers);
+    for (Worker& worker : workers) {
+        tflite::InterpreterBuilder(*model, resolver)(&worker.interpreter);
+        if (!worker.interpreter) {
+            std::cerr << "Failed to create interpreter" << std::endl;
+            return -1;
+        }
+        worker.interpreter->SetNumThreads(config.threads);
+        if (worker.interpreter->AllocateTensors() != kTfLiteOk) {
+            std::cerr << "Failed to allocate tensors" << std::endl;
+            return -1;
+        }
+        if (createPlugin != NULL) {
+            std::vector<const char*> keys = {"artifacts_folder", "num_tidl_subgraphs",
+                                             "debug_level", "allow_mixed_precision"};
+            std::vector<const char*> values = {artifacts_path, "1", "0", "1"};
+            TfLiteDelegate* delegate = createPlugin((char**)keys.data(), (char**)values.data(),
+                                                    keys.size(), tidl_error_reporter);
+            if (delegate == NULL ||
+                worker.interpreter->ModifyGraphWithDelegate(delegate) != kTfLiteOk ||
+                worker.interpreter->AllocateTensors() != kTfLiteOk) {
+                std::cerr << "Failed to apply TIDL delegate" << std::endl;
+                return -1;
+            }
+        }
+
+        const TfLiteTensor* input_tensor = worker.interpreter->input_tensor(0);
+        int total_input_size = 1;
+        for (int i = 0; i < input_tensor->dims->size; i++) {
+            total_input_size *= input_tensor->dims->data[i];
+        }
+        if (input_tensor->type != kTfLiteFloat32 || total_input_size != kNFrames * kNMfcc) {
+            std::cerr << "ERROR: Expected a float32 input of " << kNFrames * kNMfcc
+                      << " values but the model takes " << total_input_size << std::endl;
+            return -1;
+        }
+        const TfLiteTensor* output_tensor =
+            worker.interpreter->output_tensor(0);
+        if (output_tensor->type != kTfLiteFloat32) {
+            std::cerr << "ERROR: Expected a float32 output tensor" << std::endl;
+            return -1;
+        }
+
+        worker.extractor.reset(new MfccExtractor(window_samples));
+        worker.window.assign(window_samples, 0.0f);
+
+        // Warm up so first-invoke costs do not land in the first step
+        worker.extractor->compute(audio.data(), std::min(window_samples, audio.size()),
+                                  worker.interpreter->typed_input_tensor<float>(0));
+        if (worker.interpreter->Invoke() != kTfLiteOk) {
+            std::cerr << "Failed to invoke interpreter" << std::endl;
+            return -1;
+        }
+    }
+
+    std::cout << "\n=== Replay Configuration ===" << std::endl;
+    std::cout << "Mode: " << (createPlugin != NULL ? "TIDL Accelerated" : "CPU Only") << std::endl;
+    std::cout << "Rate: " << config.rate << "x, " << config.duration_s << " s of audio per stream" << std::endl;
+    std::cout << "Window: " << config.window_ms << " ms, hop: " << config.hop_ms
+              << " ms, deadline: " << config.deadline_ms << " ms" << std::endl;
+    std::cout << "Workers: " << config.workers << " x " << config.threads
+              << " thread(s), queue depth: " << config.queue_depth << std::endl;
+    std::cout << "(window, hop, deadline and latencies are audio time, i.e. wall time x rate;" << std::endl;
+    std::cout << " RTF is compute time per second of new audio)" << std::endl;
+
+    std::cout << "\n=== Replay Results ===" << std::endl;
+    std::cout << std::setw(8) << "streams" << std::setw(8) << "jobs" << std::setw(8) << "drop"
+              << std::setw(8) << "miss%" << std::setw(8) << "det%" << std::setw(9) << "p50 ms" << std::setw(9) << "p95 ms"
+              << std::setw(9) << "p99 ms" << std::setw(9) << "max ms" << std::setw(8) << "RTF"
+              << std::setw(8) << "load%" << std::setw(8) << "q avg" << std::setw(7) << "q max"
+              << std::setw(7) << "cpu%" << std::endl;
+    std::cout << std::fixed;
+
+    int sustained = 0;
+    long failures = 0;
+    for (int num_streams : config.streams) {
+        StepResult r = run_step(num_streams, config, workers, audio, file_starts);
+        long released = r.jobs + r.dropped;
+        double miss_pct = released ? 100.0 * r.misses / released : 0.0;
+        double detect_pct = r.jobs ? 100.0 * r.detections / r.jobs : 0.0;
+        std::cout << std::setw(8) << num_streams << std::setw(8) << r.jobs
+                  << std::setw(8) << r.dropped << std::setprecision(2)
+                  << std::setw(8) << miss_pct << std::setw(8) << detect_pct
+                  << std::setw(9) << r.p50_ms
+                  << std::setw(9) << r.p95_ms << std::setw(9) << r.p99_ms
+                  << std::setw(9) << r.max_ms << std::setprecision(4) << std::setw(8) << r.rtf
+                  << std::setprecision(1) << std::setw(8) << r.load_pct
+                  << std::setw(8) << r.queue_mean << std::setw(7) << r.queue_max
+                  << std::setw(7) << r.cpu_pct << std::endl;
+        failures += r.failures;
+        // Larger counts can only load the box more; a pass after a failure is noise
+        if (miss_pct > config.max_miss_pct) {
+            std::cout << "Stopping sweep: miss rate above " << config.max_miss_pct << "%" << std::endl;
+            break;
+        }
+        sustained = num_streams;
+    }
+
+    std::cout << "\n=== Capacity ===" << std::endl;
+    if (failures > 0) {
+        std::cerr << "WARNING: " << failures << " invokes failed" << std::endl;
+    }
+    if (sustained > 0) {
+        std::cout << "Sustained " << sustained << " stream(s) at " << config.rate
+                  << "x (" << sustained * config.rate << " real-time equivalent) with <= "
+                  << config.max_miss_pct << "% deadline misses (dropped windows included)" << std::endl;
+    } else {
+        std::cout << "No stream count met the " << config.max_miss_pct
+                  << "% deadline miss budget" << std::endl;
+    }
+
+    return 0;
+}